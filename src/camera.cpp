@@ -1,21 +1,13 @@
 #include "camera.h"
 #include <cmath>
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-inline float radians(float degrees) {
-    return degrees * static_cast<float>(M_PI) / 180.0f;
-}
-
 Camera::Camera(int image_width, int image_height, const point3& position, double focal_length)
     : image_width_(image_width)
     , image_height_(image_height)
     , camera_center_(position)
     , focal_length_(focal_length)
-    , yaw_(-90.0f)  // Start looking down negative Z axis
-    , pitch_(0.0f)
+    , yaw_rad_(-90.0f * kDegToRad)  // Start looking down negative Z axis
+    , pitch_rad_(0.0f)
     , front_(0, 0, -1)
     , world_up_(0, 1, 0)
     , viewport_height_(2.0)
@@ -30,17 +22,20 @@ ray Camera::get_ray(int pixel_x, int pixel_y) const {
 }
 
 void Camera::move(const vec3& offset) {
+    // Translation leaves the basis and pixel deltas untouched — only the
+    // viewport origin shifts, so skip the trig and cross products
     camera_center_ += offset;
-    update_camera_vectors();
+    update_origin();
 }
 
-void Camera::rotate(float delta_yaw, float delta_pitch) {
-    yaw_ += delta_yaw;
-    pitch_ += delta_pitch;
+void Camera::rotate(float delta_yaw_rad, float delta_pitch_rad) {
+    yaw_rad_ += delta_yaw_rad;
+    pitch_rad_ += delta_pitch_rad;
 
-    // Constrain pitch to avoid gimbal lock
-    if (pitch_ > 89.0f) pitch_ = 89.0f;
-    if (pitch_ < -89.0f) pitch_ = -89.0f;
+    // Constrain pitch to avoid gimbal lock (±89°)
+    constexpr float pitch_limit = 89.0f * kDegToRad;
+    if (pitch_rad_ > pitch_limit) pitch_rad_ = pitch_limit;
+    if (pitch_rad_ < -pitch_limit) pitch_rad_ = -pitch_limit;
 
     update_camera_vectors();
 }
@@ -49,14 +44,35 @@ void Camera::set_position(const point3& position) {
     camera_center_ = position;
 }
 
+void Camera::set_image_size(int image_width, int image_height) {
+    image_width_ = image_width;
+    image_height_ = image_height;
+    update_camera_vectors();
+}
+
 void Camera::update_camera_vectors() {
-    // Calculate new front vector from yaw and pitch
-    float yaw_rad = radians(yaw_);
-    float pitch_rad = radians(pitch_);
+    update_basis_and_deltas();
+    update_origin();
+}
 
-    front_.e[0] = cosf(yaw_rad) * cosf(pitch_rad);
-    front_.e[1] = sinf(pitch_rad);
-    front_.e[2] = sinf(yaw_rad) * cosf(pitch_rad);
+void Camera::update_basis_and_deltas() {
+    // Calculate new front vector from yaw and pitch (stored in radians, so
+    // no conversion is needed here). Each angle needs both its sine and
+    // cosine, so compute them in one sincosf call per angle — the argument
+    // reduction and polynomial setup are shared.
+    float sin_yaw, cos_yaw, sin_pitch, cos_pitch;
+#if defined(_MSC_VER)
+    sin_yaw = sinf(yaw_rad_);
+    cos_yaw = cosf(yaw_rad_);
+    sin_pitch = sinf(pitch_rad_);
+    cos_pitch = cosf(pitch_rad_);
+#else
+    __builtin_sincosf(yaw_rad_, &sin_yaw, &cos_yaw);
+    __builtin_sincosf(pitch_rad_, &sin_pitch, &cos_pitch);
+#endif
+    front_.e[0] = cos_yaw * cos_pitch;
+    front_.e[1] = sin_pitch;
+    front_.e[2] = sin_yaw * cos_pitch;
     front_ = unit_vector(front_);
 
     // Calculate right and up vectors
@@ -73,7 +89,9 @@ void Camera::update_camera_vectors() {
     // Calculate pixel delta vectors
     pixel_delta_u_ = viewport_u_ / image_width_;
     pixel_delta_v_ = viewport_v_ / image_height_;
+}
 
+void Camera::update_origin() {
     // Calculate viewport center and upper-left corner
     auto viewport_center = camera_center_ + front_ * focal_length_;
     viewport_upper_left_ = viewport_center - viewport_u_ / 2 - viewport_v_ / 2;
@@ -4,6 +4,11 @@
 #include "vec3.h"
 #include "ray.h"
 
+// Camera angles are stored in radians internally (what the trig functions
+// want); degrees only exist at the UI boundary.
+constexpr float kDegToRad = 0.017453292519943295f;
+constexpr float kRadToDeg = 57.29577951308232f;
+
 class Camera {
 public:
     Camera(int image_width, int image_height,
@@ -12,24 +17,36 @@ public:
 
     [[nodiscard]] ray get_ray(int pixel_x, int pixel_y) const;
     void move(const vec3& offset);
-    void rotate(float delta_yaw, float delta_pitch);
+    void rotate(float delta_yaw_rad, float delta_pitch_rad);
     void set_position(const point3& position);
+    void set_image_size(int image_width, int image_height);
 
     [[nodiscard]] point3 get_position() const { return camera_center_; }
     [[nodiscard]] vec3 get_forward() const { return front_; }
     [[nodiscard]] vec3 get_right() const { return camera_right_; }
     [[nodiscard]] vec3 get_up() const { return camera_up_; }
-    [[nodiscard]] float get_yaw() const { return yaw_; }
-    [[nodiscard]] float get_pitch() const { return pitch_; }
+    [[nodiscard]] float get_yaw() const { return yaw_rad_ * kRadToDeg; }
+    [[nodiscard]] float get_pitch() const { return pitch_rad_ * kRadToDeg; }
+    [[nodiscard]] float get_yaw_rad() const { return yaw_rad_; }
+    [[nodiscard]] float get_pitch_rad() const { return pitch_rad_; }
+
+    // Pixel-grid accessors, used by batched ray generation in the render loop.
+    [[nodiscard]] point3 get_pixel00_loc() const { return pixel00_loc_; }
+    [[nodiscard]] vec3 get_pixel_delta_u() const { return pixel_delta_u_; }
+    [[nodiscard]] vec3 get_pixel_delta_v() const { return pixel_delta_v_; }
 
 private:
     /**
      * @brief Update all camera vectors and viewport calculations
      *
-     * This method recalculates the camera's coordinate system and viewport
-     * parameters whenever the camera position or orientation changes.
+     * Combined helper for orientation or viewport changes: recalculates the
+     * basis and pixel deltas, then the position-dependent grid origin.
+     * Translation only needs update_origin() — the basis, viewport edges
+     * and pixel deltas are independent of where the camera sits.
      */
     void update_camera_vectors();
+    void update_basis_and_deltas();
+    void update_origin();
 
     // Image dimensions
     int image_width_;
@@ -38,8 +55,8 @@ private:
     // Camera parameters
     point3 camera_center_;
     double focal_length_;
-    float yaw_;
-    float pitch_;
+    float yaw_rad_;
+    float pitch_rad_;
 
     // Camera coordinate system
     vec3 front_;
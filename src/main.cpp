@@ -1,7 +1,6 @@
-#include "color.h"
-#include "ray.h"
 #include "vec3.h"
 #include "camera.h"
+#include "render.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -11,71 +10,15 @@
 
 #include <iostream>
 #include <vector>
+#include <cstdint>
 #include <algorithm>
 #include <cmath>
-
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-/**
- * ----- Sphere -----
- * center of Sphere: C(x0, y0, z0)
- * radius: r²
- * Notation: (x-x0)² + (y-y0)² + (z-z0)² = r²
- * Vector notation: ∥ P - C ∥² = r²
- *
- * (P is any point, C is center of sphere)
- *
- * ----- Ray -----
- * formula: P(t) = A + tB
- *
- * (A is origin of ray, B is direction of ray)
- *
- * So the equation of Sphere could be written as: ∥P(t) - C∥² = r²
- * And rewritten: ∥ O + tB∥² = r² where O = A - C
- *
- * We can now develop it as:
- * = (O + tB) ⋅ (O + tB) = r²
- * = (O ⋅ O) + 2t(O ⋅ B) + t²(B ⋅ B) = 0
- *
- * if the result of above calculation is >= to 0 we assume it's ok.
- * but we can actually improve it using for getting the value of 't' that represents the distance (or “time”) it takes to travel along the radius to reach the sphere.
- * if the discriminant >= 0 then:
- * t = (-b - sqrt(discriminant)) / 2a
- *
- * @param center
- * @param radius
- * @param r
- * @return
- */
-double hit_sphere(const point3& center, double radius, const ray& r)
-{
-    vec3 originSphere = r.origin() - center; // O = A - C
-    auto a = r.direction().length_squared(); // O ⋅ O or squared length
-    auto b = 2 * dot(originSphere, r.direction()); // 2(O ⋅ B)
-    auto c = originSphere.length_squared() - radius * radius; // O ⋅ O (or squared length) - r²
-    auto discriminant = b * b - 4 * a * c; // at² + bt + c = 0
-
-    return discriminant < 0
-               ? -1.0
-               : (-b - sqrt(discriminant)) / (2.0 * a);
-}
-
-color ray_color(const ray& r)
-{
-    auto t = hit_sphere(point3(0, 0, -1), 0.5, r);
-    if (t > 0.0)
-    {
-        vec3 N = unit_vector(r.at(t) - vec3(0, 0, -1));
-        return 0.5 * color(N.x() + 1, N.y() + 1, N.z() + 1);
-    }
-
-    vec3 unit_direction = unit_vector(r.direction());
-    auto a = 0.5 * (unit_direction.y() + 1.0);
-
-    return (1.0 - a) * color(1.0, 1.0, 1.0) + a * color(0.5, 0.7, 1.0);
-}
+#include <cstring>
+#include <new>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 // Shaders for quad display
 const char* vertexShaderSource = R"(
@@ -97,6 +40,46 @@ void main() {
     FragColor = texture(screenTexture, TexCoord);
 })";
 
+// GPU port of hit_sphere + ray_color: every fragment reconstructs its ray
+// from the camera uniforms and shades it directly, so there is no CPU
+// framebuffer and no texture upload on this path. The pixel mapping matches
+// the CPU renderer exactly (TexCoord * resolution - 0.5 lands on the same
+// pixel centers that pixel00 + i*du + j*dv produces).
+const char* raytraceFragmentShaderSource = R"(
+#version 330 core
+out vec4 FragColor;
+in vec2 TexCoord;
+uniform vec3 uCamPos;
+uniform vec3 uPixel00;
+uniform vec3 uPixelDU;
+uniform vec3 uPixelDV;
+uniform vec2 uResolution;
+
+float hit_sphere(vec3 center, float radius, vec3 ray_origin, vec3 ray_dir) {
+    vec3 oc = ray_origin - center;
+    float a = dot(ray_dir, ray_dir);
+    float b = 2.0 * dot(oc, ray_dir);
+    float c = dot(oc, oc) - radius * radius;
+    float disc = b * b - 4.0 * a * c;
+    return disc < 0.0 ? -1.0 : (-b - sqrt(disc)) / (2.0 * a);
+}
+
+void main() {
+    vec2 pixel = TexCoord * uResolution - 0.5;
+    vec3 ray_dir = uPixel00 + pixel.x * uPixelDU + pixel.y * uPixelDV - uCamPos;
+
+    float t = hit_sphere(vec3(0.0, 0.0, -1.0), 0.5, uCamPos, ray_dir);
+    vec3 col;
+    if (t > 0.0) {
+        vec3 N = normalize(uCamPos + t * ray_dir - vec3(0.0, 0.0, -1.0));
+        col = 0.5 * (N + 1.0);
+    } else {
+        float a = 0.5 * (normalize(ray_dir).y + 1.0);
+        col = mix(vec3(1.0), vec3(0.5, 0.7, 1.0), a);
+    }
+    FragColor = vec4(col, 1.0);
+})";
+
 // Utility function to compile a shader
 GLuint compileShader(GLenum type, const char* src) {
     GLuint shader = glCreateShader(type);
@@ -125,6 +108,13 @@ int main() {
     int image_width = 1280; // Example: 1280x720 (HD, < 1920x1080)
     int image_height = 720;
 
+    // Preview resolution used by the CPU path while the camera is moving;
+    // 16x fewer pixels, upsampled by the GL_LINEAR sampler on the quad. The
+    // full-res frame is scheduled once input has been quiet for a moment.
+    constexpr int preview_width = 320;
+    constexpr int preview_height = 180;
+    constexpr double idle_delay_s = 0.15;
+
     // Create GLFW window in 16/9
     GLFWwindow* window = glfwCreateWindow(image_width, image_height, "RayTracer", nullptr, nullptr);
     if (!window) {
@@ -149,29 +139,83 @@ int main() {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
 
-    // Dynamic image variables
-    std::vector<unsigned char> framebuffer(image_width * image_height * 3);
+    // Double-buffered framebuffers: the render thread fills the back buffer
+    // while the main thread uploads the front one, so the UI never waits for
+    // a full raytrace. front_idx names the buffer that is safe to upload;
+    // each buffer has its own mutex so upload and render only contend when
+    // they actually target the same buffer.
+    FramebufferVec framebuffers[2] = {
+        FramebufferVec(image_width * image_height),
+        FramebufferVec(image_width * image_height)
+    };
+    std::mutex framebuffer_mutex[2];
+    std::atomic<int> front_idx{0};
+    // Resolution each buffer was rendered at (preview or full); written by
+    // the render thread and read by the uploader under the buffer's mutex
+    int framebuffer_w[2] = {image_width, image_width};
+    int framebuffer_h[2] = {image_height, image_height};
 
     // Initialize Camera
     Camera camera(image_width, image_height, point3(0, 0, 0), 1.0);
     float camera_speed = 1.0f;
 
-    // Helper function to render the scene
-    auto render_scene = [&]() {
-        for (int j = 0; j < image_height; j++) {
-            for (int i = 0; i < image_width; i++) {
-                ray r = camera.get_ray(i, j);
-                color pixel_color = ray_color(r);
-                int idx = (j * image_width + i) * 3;
-                framebuffer[idx + 0] = static_cast<unsigned char>(256 * std::clamp(pixel_color.x(), 0.0, 0.999));
-                framebuffer[idx + 1] = static_cast<unsigned char>(256 * std::clamp(pixel_color.y(), 0.0, 0.999));
-                framebuffer[idx + 2] = static_cast<unsigned char>(256 * std::clamp(pixel_color.z(), 0.0, 0.999));
+    // Render-thread state: the main thread publishes the newest camera under
+    // render_mutex and bumps pending_version; the worker snapshots it and
+    // renders. Intermediate camera states are coalesced — only the newest
+    // one is ever rendered.
+    std::mutex render_mutex;
+    std::condition_variable render_cv;
+    Camera pending_camera = camera;
+    int pending_width = image_width;
+    int pending_height = image_height;
+    uint64_t pending_version = 0;
+    bool render_thread_running = true;
+
+    std::thread render_thread([&]() {
+        uint64_t rendered_version = 0;
+        while (true) {
+            std::unique_lock<std::mutex> lock(render_mutex);
+            render_cv.wait(lock, [&] {
+                return !render_thread_running || pending_version != rendered_version;
+            });
+            if (!render_thread_running) {
+                return;
             }
+            Camera snapshot = pending_camera;
+            const int render_w = pending_width;
+            const int render_h = pending_height;
+            rendered_version = pending_version;
+            lock.unlock();
+
+            // Retarget the pixel grid to the requested resolution (the
+            // aspect ratio is the same, so the view is unchanged)
+            snapshot.set_image_size(render_w, render_h);
+
+            const int back = 1 - front_idx.load(std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(framebuffer_mutex[back]);
+                render_framebuffer(snapshot, render_w, render_h, framebuffers[back].data());
+                framebuffer_w[back] = render_w;
+                framebuffer_h[back] = render_h;
+            }
+            front_idx.store(back, std::memory_order_release);
+        }
+    });
+
+    // Publishes the current camera to the render thread
+    auto request_render = [&](int render_w, int render_h) {
+        {
+            std::lock_guard<std::mutex> lock(render_mutex);
+            pending_camera = camera;
+            pending_width = render_w;
+            pending_height = render_h;
+            ++pending_version;
         }
+        render_cv.notify_one();
     };
 
-    // Initial render
-    render_scene();
+    // Initial render (synchronous, so the first frame has a valid texture)
+    render_framebuffer(camera, image_width, image_height, framebuffers[0].data());
 
     // OpenGL texture creation
     GLuint tex = 0;
@@ -179,7 +223,24 @@ int main() {
     glBindTexture(GL_TEXTURE_2D, tex);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image_width, image_height, 0, GL_RGB, GL_UNSIGNED_BYTE, framebuffer.data());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image_width, image_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, framebuffers[0].data());
+    int tex_w = image_width;  // resolution currently allocated for the texture
+    int tex_h = image_height;
+
+    // Ping-pong pixel unpack buffers for texture upload: the CPU writes into
+    // a freshly orphaned, mapped buffer while the driver DMAs the previous
+    // one, so glTexSubImage2D no longer blocks on a synchronous copy.
+    // (Persistent mapping would avoid the map/unmap too, but needs GL 4.4's
+    // glBufferStorage — this context is 3.3 core.)
+    const size_t framebuffer_size = static_cast<size_t>(image_width) * image_height * 4;
+    GLuint upload_pbos[2] = {0, 0};
+    glGenBuffers(2, upload_pbos);
+    for (GLuint pbo : upload_pbos) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, framebuffer_size, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    int upload_pbo_index = 0;
 
     // Shader program creation for fullscreen quad
     GLuint vertShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
@@ -190,6 +251,24 @@ int main() {
     glLinkProgram(shaderProgram);
     glDeleteShader(vertShader);
     glDeleteShader(fragShader);
+    // Uniform locations are fixed after linking — look them up once, never
+    // inside the frame loop
+    GLint uScreenTexture = glGetUniformLocation(shaderProgram, "screenTexture");
+
+    // Second program: the raytracer itself as a fragment shader
+    GLuint rtVertShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
+    GLuint rtFragShader = compileShader(GL_FRAGMENT_SHADER, raytraceFragmentShaderSource);
+    GLuint raytraceProgram = glCreateProgram();
+    glAttachShader(raytraceProgram, rtVertShader);
+    glAttachShader(raytraceProgram, rtFragShader);
+    glLinkProgram(raytraceProgram);
+    glDeleteShader(rtVertShader);
+    glDeleteShader(rtFragShader);
+    GLint uCamPos = glGetUniformLocation(raytraceProgram, "uCamPos");
+    GLint uPixel00 = glGetUniformLocation(raytraceProgram, "uPixel00");
+    GLint uPixelDU = glGetUniformLocation(raytraceProgram, "uPixelDU");
+    GLint uPixelDV = glGetUniformLocation(raytraceProgram, "uPixelDV");
+    GLint uResolution = glGetUniformLocation(raytraceProgram, "uResolution");
 
     // Fullscreen quad (2 triangles)
     float quadVertices[] = {
@@ -221,6 +300,20 @@ int main() {
     double lastMouseX = 0.0, lastMouseY = 0.0;
     float sensitivity = 0.2f;
     bool invertY = true;
+    int last_uploaded_idx = 0; // framebuffers[0] was uploaded at texture creation
+    bool gpu_raytrace = true;  // raytrace in the fragment shader vs on the CPU
+
+    // Camera state of the last frame handed to the render thread; CPU
+    // re-renders are skipped while the accumulated motion since then stays
+    // below ~half a pixel on screen
+    point3 last_rendered_pos = camera.get_position();
+    float last_rendered_yaw = camera.get_yaw_rad();
+    float last_rendered_pitch = camera.get_pitch_rad();
+
+    // Progressive resolution: previews are rendered while input is coming
+    // in, and the full-res frame is scheduled after idle_delay_s of quiet
+    double last_input_time = glfwGetTime();
+    bool full_res_pending = false;
 
     while (!glfwWindowShouldClose(window)) {
         double currentFrameTime = glfwGetTime();
@@ -247,7 +340,9 @@ int main() {
 
                 float delta_yaw = static_cast<float>(offsetX) * sensitivity;
                 float delta_pitch = static_cast<float>(invertY ? offsetY : -offsetY) * sensitivity;
-                camera.rotate(delta_yaw, delta_pitch);
+                // Sensitivity is tuned in degrees per mouse count; the
+                // camera itself works in radians
+                camera.rotate(delta_yaw * kDegToRad, delta_pitch * kDegToRad);
                 camera_updated = true;
             }
         } else {
@@ -283,11 +378,83 @@ int main() {
             camera_updated = true;
         }
 
-        // Re-render if camera changed
+        // Hand the new camera state to the render thread; the UI keeps
+        // running while the frame is computed in the background. The GPU
+        // path needs neither — it rebuilds the image from uniforms every
+        // frame. Deltas accumulate across frames, so a slow drag still
+        // renders once the motion adds up to something visible.
+        if (camera_updated && !gpu_raytrace) {
+            // Approximate screen-space shift in pixels: translation in units
+            // of one pixel step on the viewport, plus rotation converted
+            // through the per-pixel viewing angle (focal length 1)
+            const float pixel_size = camera.get_pixel_delta_u().length();
+            const float translation_pixels =
+                (camera.get_position() - last_rendered_pos).length() / pixel_size;
+            // Angles are radians, which at focal length 1 are already the
+            // arc length on the viewport
+            const float rotation_pixels =
+                (std::abs(camera.get_yaw_rad() - last_rendered_yaw) +
+                 std::abs(camera.get_pitch_rad() - last_rendered_pitch)) / pixel_size;
+
+            if (translation_pixels + rotation_pixels > 0.5f) {
+                request_render(preview_width, preview_height);
+                last_rendered_pos = camera.get_position();
+                last_rendered_yaw = camera.get_yaw_rad();
+                last_rendered_pitch = camera.get_pitch_rad();
+                full_res_pending = true;
+            }
+        }
         if (camera_updated) {
-            render_scene();
-            glBindTexture(GL_TEXTURE_2D, tex);
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image_width, image_height, GL_RGB, GL_UNSIGNED_BYTE, framebuffer.data());
+            last_input_time = currentFrameTime;
+        }
+
+        // Input has settled: replace the preview with a full-res frame
+        if (!gpu_raytrace && full_res_pending &&
+            currentFrameTime - last_input_time > idle_delay_s) {
+            request_render(image_width, image_height);
+            full_res_pending = false;
+        }
+
+        // Upload the newest completed frame, if the render thread finished
+        // one since the last upload
+        if (!gpu_raytrace) {
+            const int front = front_idx.load(std::memory_order_acquire);
+            if (front != last_uploaded_idx) {
+                std::lock_guard<std::mutex> lock(framebuffer_mutex[front]);
+                const int upload_w = framebuffer_w[front];
+                const int upload_h = framebuffer_h[front];
+                const size_t upload_size = static_cast<size_t>(upload_w) * upload_h * 4;
+                glBindTexture(GL_TEXTURE_2D, tex);
+
+                // The texture tracks the rendered resolution (preview or
+                // full); the GL_LINEAR sampler on the quad upsamples
+                if (upload_w != tex_w || upload_h != tex_h) {
+                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, upload_w, upload_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                    tex_w = upload_w;
+                    tex_h = upload_h;
+                }
+
+                // Orphan the PBO so mapping never waits on an in-flight DMA,
+                // copy the frame in, then kick off the async upload (the
+                // null offset makes glTexSubImage2D read from the PBO)
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload_pbos[upload_pbo_index]);
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, upload_size, nullptr, GL_STREAM_DRAW);
+                void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, upload_size,
+                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+                if (mapped) {
+                    std::memcpy(mapped, framebuffers[front].data(), upload_size);
+                    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, upload_w, upload_h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                } else {
+                    // Mapping can fail (e.g. out of driver memory); fall back
+                    // to the plain synchronous upload
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, upload_w, upload_h, GL_RGBA, GL_UNSIGNED_BYTE, framebuffers[front].data());
+                }
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                upload_pbo_index = 1 - upload_pbo_index;
+
+                last_uploaded_idx = front;
+            }
         }
 
         // ImGui
@@ -307,13 +474,17 @@ int main() {
         ImGui::Text("Mouse Controls:");
         ImGui::SliderFloat("Sensitivity", &sensitivity, 0.1f, 2.0f);
         ImGui::Checkbox("Invert Y-axis", &invertY);
+        ImGui::Separator();
+        if (ImGui::Checkbox("Raytrace on GPU", &gpu_raytrace) && !gpu_raytrace) {
+            request_render(image_width, image_height); // refresh the CPU image when switching back
+        }
         ImGui::End();
 
-        // If reload requested, recalculate image and reload texture
+        // If reload requested, schedule a fresh frame
         if (reload) {
-            render_scene();
-            glBindTexture(GL_TEXTURE_2D, tex);
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image_width, image_height, GL_RGB, GL_UNSIGNED_BYTE, framebuffer.data());
+            if (!gpu_raytrace) {
+                request_render(image_width, image_height);
+            }
             reload = false;
         }
 
@@ -323,10 +494,26 @@ int main() {
         glViewport(0, 0, display_w, display_h);
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
-        glUseProgram(shaderProgram);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, tex);
-        glUniform1i(glGetUniformLocation(shaderProgram, "screenTexture"), 0);
+        if (gpu_raytrace) {
+            // Raytrace in the fragment shader: only a handful of uniform
+            // floats travel to the GPU per frame, the image itself never
+            // leaves it
+            const point3 cam_pos = camera.get_position();
+            const point3 pixel00 = camera.get_pixel00_loc();
+            const vec3 du = camera.get_pixel_delta_u();
+            const vec3 dv = camera.get_pixel_delta_v();
+            glUseProgram(raytraceProgram);
+            glUniform3f(uCamPos, cam_pos.x(), cam_pos.y(), cam_pos.z());
+            glUniform3f(uPixel00, pixel00.x(), pixel00.y(), pixel00.z());
+            glUniform3f(uPixelDU, du.x(), du.y(), du.z());
+            glUniform3f(uPixelDV, dv.x(), dv.y(), dv.z());
+            glUniform2f(uResolution, static_cast<float>(image_width), static_cast<float>(image_height));
+        } else {
+            glUseProgram(shaderProgram);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, tex);
+            glUniform1i(uScreenTexture, 0);
+        }
         glBindVertexArray(quadVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glBindVertexArray(0);
@@ -338,6 +525,15 @@ int main() {
         glfwSwapBuffers(window);
     }
 
+    // Stop the render thread before tearing anything down
+    {
+        std::lock_guard<std::mutex> lock(render_mutex);
+        render_thread_running = false;
+    }
+    render_cv.notify_one();
+    render_thread.join();
+
+    glDeleteBuffers(2, upload_pbos);
     glDeleteTextures(1, &tex);
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
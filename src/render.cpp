@@ -0,0 +1,39 @@
+#include "render.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <isa_availability.h>
+#endif
+
+namespace {
+
+using render_fn = void (*)(const Camera&, int, int, uint32_t*);
+
+// Picks the widest kernel the host CPU supports. Evaluated once during
+// static initialization, so the per-frame cost of the dispatch is a single
+// indirect call. A 16-wide AVX-512 kernel would slot in here the same way
+// once one exists.
+render_fn select_render_fn() {
+#ifdef RAYTRACER_HAVE_AVX2_KERNEL
+#if defined(__GNUC__) || defined(__clang__)
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return render_framebuffer_avx2;
+    }
+#elif defined(_MSC_VER)
+    if (__isa_available >= __ISA_AVAILABLE_AVX2) {
+        return render_framebuffer_avx2;
+    }
+#endif
+#endif
+    return render_framebuffer_scalar;
+}
+
+const render_fn g_render = select_render_fn();
+
+} // namespace
+
+void render_framebuffer(const Camera& camera, int image_width, int image_height,
+                        uint32_t* framebuffer)
+{
+    g_render(camera, image_width, image_height, framebuffer);
+}
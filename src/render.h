@@ -0,0 +1,59 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "camera.h"
+
+#include <cstdint>
+#include <new>
+#include <vector>
+
+/**
+ * Renders the whole scene into an RGBA8 framebuffer (one 32-bit pixel per
+ * store, alpha hardwired to 0xFF). Single entry point for every render
+ * trigger (startup, camera updates, manual reload); dispatches once at
+ * startup to the widest kernel this CPU supports — the AVX2+FMA
+ * translation unit when both the build and the host provide it, otherwise
+ * the portable scalar one.
+ *
+ * @param camera camera providing ray origins/directions
+ * @param image_width framebuffer width in pixels
+ * @param image_height framebuffer height in pixels
+ * @param framebuffer destination, image_width * image_height pixels
+ */
+void render_framebuffer(const Camera& camera, int image_width, int image_height,
+                        uint32_t* framebuffer);
+
+// ISA-specific entry points, one per translation unit compiled with the
+// matching flags (render_impl.h provides the shared body). Prefer
+// render_framebuffer, which picks the best one at startup.
+void render_framebuffer_scalar(const Camera& camera, int image_width, int image_height,
+                               uint32_t* framebuffer);
+#ifdef RAYTRACER_HAVE_AVX2_KERNEL
+void render_framebuffer_avx2(const Camera& camera, int image_width, int image_height,
+                             uint32_t* framebuffer);
+#endif
+
+// Minimal aligned allocator so the framebuffers start cache-line aligned:
+// the SIMD writeout needs 32 bytes for its non-temporal stores, and the
+// full 64 keeps rows from straddling lines shared with unrelated data.
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+    bool operator==(const AlignedAllocator&) const { return true; }
+    bool operator!=(const AlignedAllocator&) const { return false; }
+};
+
+using FramebufferVec = std::vector<uint32_t, AlignedAllocator<uint32_t, 64>>;
+
+#endif // RENDER_H
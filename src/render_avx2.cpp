@@ -0,0 +1,5 @@
+// AVX2+FMA kernel: CMake compiles this file (and only this file) with
+// -mavx2 -mfma / /arch:AVX2, so render_impl.h takes its SIMD arm while the
+// rest of the binary stays runnable on older CPUs.
+#define RT_RENDER_IMPL_NAME render_framebuffer_avx2
+#include "render_impl.h"
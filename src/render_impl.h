@@ -0,0 +1,366 @@
+// Shared body of the render kernel, compiled once per ISA translation unit:
+// render_scalar.cpp includes it with no SIMD flags and render_avx2.cpp with
+// -mavx2 -mfma, so the RAYTRACER_USE_AVX2 arm below is selected purely by
+// the compile flags of the including TU. RT_RENDER_IMPL_NAME names the
+// function each TU emits; everything else has internal linkage.
+
+#include "render.h"
+#include "color.h"
+#include "ray.h"
+#include "vec3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#define RAYTRACER_USE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#ifndef RT_RENDER_IMPL_NAME
+#error "render_impl.h must be included with RT_RENDER_IMPL_NAME defined"
+#endif
+
+namespace {
+
+// The one sphere in the scene, hoisted to TU scope so no per-ray temporaries
+// are built for it and the compiler can fold the components straight into
+// the kernels.
+constexpr point3 kSphereCenter(0.0f, 0.0f, -1.0f);
+constexpr float kSphereRadius = 0.5f;
+constexpr float kSphereRadiusSquared = kSphereRadius * kSphereRadius;
+
+
+// Tile dimensions for the blocked render loop. 64x16 rather than a square
+// 16x16: a 64-pixel-wide tile row spans four full cache lines of RGBA
+// output (no partially written lines at tile seams) and gives the 8-wide
+// SIMD loop eight full iterations per row, while 16 rows keep the tile's
+// ~4 KB output slab resident in L1. The (jj, ii) tile grid is also the
+// OpenMP work unit.
+constexpr int kTileW = 64;
+constexpr int kTileH = 16;
+
+/**
+ * ----- Sphere -----
+ * center of Sphere: C(x0, y0, z0)
+ * radius: r²
+ * Notation: (x-x0)² + (y-y0)² + (z-z0)² = r²
+ * Vector notation: ∥ P - C ∥² = r²
+ *
+ * (P is any point, C is center of sphere)
+ *
+ * ----- Ray -----
+ * formula: P(t) = A + tB
+ *
+ * (A is origin of ray, B is direction of ray)
+ *
+ * So the equation of Sphere could be written as: ∥P(t) - C∥² = r²
+ * And rewritten: ∥ O + tB∥² = r² where O = A - C
+ *
+ * We can now develop it as:
+ * = (O + tB) ⋅ (O + tB) = r²
+ * = (O ⋅ O) + 2t(O ⋅ B) + t²(B ⋅ B) = 0
+ *
+ * if the result of above calculation is >= to 0 we assume it's ok.
+ * but we can actually improve it using for getting the value of 't' that represents the distance (or “time”) it takes to travel along the radius to reach the sphere.
+ * if the discriminant >= 0 then:
+ * t = (-b - sqrt(discriminant)) / 2a
+ *
+ * With a unit-length direction a = B ⋅ B = 1, so using the half-form
+ * b = O ⋅ B̂ the whole thing collapses to t = -b - sqrt(b² - c): no 2·, no
+ * 4ac, no divide. The caller normalizes the direction once and reuses it
+ * for the sky gradient.
+ *
+ * @param center
+ * @param radius_squared
+ * @param origin
+ * @param unit_dir normalized ray direction
+ * @return distance along unit_dir, or -1 on miss
+ */
+RT_FORCE_INLINE float hit_sphere(const point3& center, float radius_squared,
+                                 const point3& origin, const vec3& unit_dir)
+{
+    vec3 originSphere = origin - center; // O = A - C
+    auto b = dot(originSphere, unit_dir); // O ⋅ B̂ (half-form b)
+    auto c = originSphere.length_squared() - radius_squared;
+    auto discriminant = b * b - c;
+
+    return discriminant < 0
+               ? -1.0f
+               : -b - std::sqrt(discriminant);
+}
+
+// Variant for callers that already know |direction|²: with
+// d(i) = row_start + i * pixel_delta_u, the squared length obeys a
+// quadratic recurrence (two adds per pixel), so the render loop can feed
+// it in and skip the per-pixel dot product.
+RT_FORCE_INLINE color ray_color(const ray& r, float dir_length_squared)
+{
+    // Normalize once; both the sphere test (a = 1) and the sky gradient
+    // reuse the unit direction
+    float inv_len = 1.0f / std::sqrt(dir_length_squared);
+    vec3 unit_dir = r.direction() * inv_len;
+
+    auto t = hit_sphere(kSphereCenter, kSphereRadiusSquared, r.origin(), unit_dir);
+
+    // Evaluate both the hit shading and the sky gradient unconditionally and
+    // select at the end — the silhouette of the sphere makes the old
+    // if (t > 0) branch unpredictable across a row, and a select compiles to
+    // a cmov/blend instead of a mispredict. Clamping t at 0 keeps the hit
+    // path finite for missed rays.
+    vec3 N = unit_vector(r.origin() + std::max(t, 0.0f) * unit_dir - kSphereCenter);
+    color hit = 0.5f * color(N.x() + 1, N.y() + 1, N.z() + 1);
+
+    auto a = 0.5f * (unit_dir.y() + 1.0f);
+    color sky = (1.0f - a) * color(1.0f, 1.0f, 1.0f) + a * color(0.5f, 0.7f, 1.0f);
+
+    return t > 0.0f ? hit : sky;
+}
+
+RT_FORCE_INLINE color ray_color(const ray& r)
+{
+    return ray_color(r, r.direction().length_squared());
+}
+
+#ifdef RAYTRACER_USE_AVX2
+/**
+ * Fast reciprocal square root: hardware rsqrt estimate (~12-bit) refined
+ * with one Newton-Raphson step to ~23 bits — well below the 8-bit output
+ * quantization, at a fraction of the cost of sqrt + div.
+ */
+RT_FORCE_INLINE __m256 rsqrt_nr(__m256 x)
+{
+    __m256 r = _mm256_rsqrt_ps(x);
+    __m256 half_x = _mm256_mul_ps(_mm256_set1_ps(0.5f), x);
+    // r = r * (1.5 - 0.5 * x * r * r)
+    return _mm256_mul_ps(r, _mm256_fnmadd_ps(half_x, _mm256_mul_ps(r, r), _mm256_set1_ps(1.5f)));
+}
+
+/**
+ * ----- Batched ray evaluation (AVX2, float) -----
+ * Evaluates ray_color for 8 rays at once: each __m256 holds one component
+ * (x, y or z) of 8 ray origins or directions in float, so the sphere
+ * quadratic (a, b, c, discriminant) and the hit/sky selection run in
+ * lockstep across all 8 lanes. Both colors are computed unconditionally and
+ * the final value is picked per lane with a mask + blend, so there is no
+ * branch divergence. Float precision is plenty here: the output is
+ * quantized to 8 bits per channel anyway.
+ *
+ * @param ox,oy,oz components of the 8 ray origins
+ * @param dx,dy,dz components of the 8 ray directions
+ * @param out_r,out_g,out_b resulting color components, one lane per ray
+ */
+RT_FORCE_INLINE void ray_color_x8(__m256 ox, __m256 oy, __m256 oz,
+                  __m256 dx, __m256 dy, __m256 dz,
+                  __m256* out_r, __m256* out_g, __m256* out_b)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    // O = A - C
+    __m256 ocx = _mm256_sub_ps(ox, _mm256_set1_ps(kSphereCenter.x()));
+    __m256 ocy = _mm256_sub_ps(oy, _mm256_set1_ps(kSphereCenter.y()));
+    __m256 ocz = _mm256_sub_ps(oz, _mm256_set1_ps(kSphereCenter.z()));
+
+    // Normalize the directions up front: with a = B̂ ⋅ B̂ = 1 the quadratic
+    // collapses to its half-form (b = O ⋅ B̂, disc = b² - c) — no 2·, no 4ac
+    // and no 2a divide. The sky gradient was already paying for rsqrt(B ⋅ B),
+    // so the normalization itself costs only three extra multiplies.
+    __m256 d_len2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+    __m256 inv_d_len = rsqrt_nr(d_len2);
+    __m256 udx = _mm256_mul_ps(dx, inv_d_len);
+    __m256 udy = _mm256_mul_ps(dy, inv_d_len);
+    __m256 udz = _mm256_mul_ps(dz, inv_d_len);
+
+    // b = O ⋅ B̂ (half-form), c = O ⋅ O - r²
+    __m256 b = _mm256_fmadd_ps(ocx, udx, _mm256_fmadd_ps(ocy, udy, _mm256_mul_ps(ocz, udz)));
+    __m256 c = _mm256_fmadd_ps(ocx, ocx,
+                               _mm256_fmadd_ps(ocy, ocy,
+                                               _mm256_fmsub_ps(ocz, ocz, _mm256_set1_ps(kSphereRadiusSquared))));
+
+    // discriminant = b² - c; sqrt is taken unconditionally (lanes with a
+    // negative discriminant are discarded by the mask below). The floor
+    // keeps rsqrt away from 0 (where the estimate is inf); the resulting
+    // error is far below output quantization.
+    __m256 disc = _mm256_fmsub_ps(b, b, c);
+    __m256 disc_safe = _mm256_max_ps(disc, _mm256_set1_ps(1e-30f));
+    // sqrt(x) = x * rsqrt(x); one rsqrt + NR replaces the sqrt
+    __m256 sqrt_disc = _mm256_mul_ps(disc_safe, rsqrt_nr(disc_safe));
+    __m256 t = _mm256_sub_ps(_mm256_sub_ps(zero, b), sqrt_disc);
+
+    __m256 hit_mask = _mm256_and_ps(_mm256_cmp_ps(disc, zero, _CMP_GE_OQ),
+                                    _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+
+    // Hit color: 0.5 * (N + 1) with N = unit_vector(P - C); clamp t at 0 so
+    // missed lanes still compute finite (discarded) values
+    __m256 t_safe = _mm256_max_ps(t, zero);
+    __m256 nx = _mm256_fmadd_ps(t_safe, udx, ocx);
+    __m256 ny = _mm256_fmadd_ps(t_safe, udy, ocy);
+    __m256 nz = _mm256_fmadd_ps(t_safe, udz, ocz);
+    __m256 n_len2 = _mm256_fmadd_ps(nx, nx, _mm256_fmadd_ps(ny, ny, _mm256_mul_ps(nz, nz)));
+    __m256 inv_n_len = rsqrt_nr(n_len2);
+    __m256 hit_r = _mm256_mul_ps(half, _mm256_fmadd_ps(nx, inv_n_len, one));
+    __m256 hit_g = _mm256_mul_ps(half, _mm256_fmadd_ps(ny, inv_n_len, one));
+    __m256 hit_b = _mm256_mul_ps(half, _mm256_fmadd_ps(nz, inv_n_len, one));
+
+    // Sky gradient: lerp(white, (0.5, 0.7, 1.0), 0.5 * (unit_dir.y + 1))
+    __m256 s = _mm256_mul_ps(half, _mm256_add_ps(udy, one));
+    __m256 sky_r = _mm256_fnmadd_ps(s, _mm256_set1_ps(0.5f), one);
+    __m256 sky_g = _mm256_fnmadd_ps(s, _mm256_set1_ps(0.3f), one);
+    __m256 sky_b = one;
+
+    *out_r = _mm256_blendv_ps(sky_r, hit_r, hit_mask);
+    *out_g = _mm256_blendv_ps(sky_g, hit_g, hit_mask);
+    *out_b = _mm256_blendv_ps(sky_b, hit_b, hit_mask);
+}
+#endif // RAYTRACER_USE_AVX2
+
+} // namespace
+
+/**
+ * Renders the whole scene into an RGBA8 framebuffer (one 32-bit pixel per
+ * store, alpha hardwired to 0xFF). Single entry point for every render
+ * trigger (startup, camera updates, manual reload) so loop restructurings
+ * and kernel changes are made exactly once.
+ *
+ * @param camera camera providing ray origins/directions
+ * @param image_width framebuffer width in pixels
+ * @param image_height framebuffer height in pixels
+ * @param framebuffer destination, image_width * image_height pixels
+ */
+void RT_RENDER_IMPL_NAME(const Camera& camera, int image_width, int image_height,
+                         uint32_t* framebuffer)
+{
+    const point3 origin = camera.get_position();
+    const point3 pixel00_loc = camera.get_pixel00_loc();
+    const vec3 pixel_delta_u = camera.get_pixel_delta_u();
+    const vec3 pixel_delta_v = camera.get_pixel_delta_v();
+
+#ifdef RAYTRACER_USE_AVX2
+    const __m256 ox = _mm256_set1_ps(origin.x());
+    const __m256 oy = _mm256_set1_ps(origin.y());
+    const __m256 oz = _mm256_set1_ps(origin.z());
+
+    // SoA ramp table: the i-dependent part of each direction component,
+    // i * pixel_delta_u, repacked as contiguous floats so the 8-wide loop
+    // gets unit-stride loads instead of gathers. The camera itself stays
+    // in double; only the per-ray hot path is float.
+    std::vector<float> ramp_x(image_width), ramp_y(image_width), ramp_z(image_width);
+    for (int i = 0; i < image_width; i++) {
+        ramp_x[i] = i * pixel_delta_u.x();
+        ramp_y[i] = i * pixel_delta_u.y();
+        ramp_z[i] = i * pixel_delta_u.z();
+    }
+
+    // Each tile writes a disjoint framebuffer region, so no
+    // synchronization is needed across the parallel tile grid.
+#pragma omp parallel for collapse(2) schedule(dynamic)
+    for (int jj = 0; jj < image_height; jj += kTileH) {
+        for (int ii = 0; ii < image_width; ii += kTileW) {
+            const int j_end = std::min(jj + kTileH, image_height);
+            const int i_end = std::min(ii + kTileW, image_width);
+            // Direction of the tile's first row; advances by one
+            // pixel_delta_v per row, so only i * pixel_delta_u varies
+            // across a row and no per-row multiply is left
+            vec3 row_base = pixel00_loc + jj * pixel_delta_v - origin;
+            for (int j = jj; j < j_end; j++, row_base += pixel_delta_v) {
+                const __m256 base_x = _mm256_set1_ps(row_base.x());
+                const __m256 base_y = _mm256_set1_ps(row_base.y());
+                const __m256 base_z = _mm256_set1_ps(row_base.z());
+
+                int i = ii;
+                for (; i + 8 <= i_end; i += 8) {
+                    __m256 dx = _mm256_add_ps(_mm256_loadu_ps(&ramp_x[i]), base_x);
+                    __m256 dy = _mm256_add_ps(_mm256_loadu_ps(&ramp_y[i]), base_y);
+                    __m256 dz = _mm256_add_ps(_mm256_loadu_ps(&ramp_z[i]), base_z);
+
+                    __m256 r, g, b;
+                    ray_color_x8(ox, oy, oz, dx, dy, dz, &r, &g, &b);
+
+                    // Branchless clamp + scale + pack: the same
+                    // 256 * clamp(x, 0, 0.999) as the scalar path, but for
+                    // all 8 pixels per channel at once, packed down to bytes
+                    // with saturating pack instructions
+                    const __m256 lo = _mm256_setzero_ps();
+                    const __m256 hi = _mm256_set1_ps(0.999f);
+                    const __m256 scale = _mm256_set1_ps(256.0f);
+                    __m256i ri = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(r, lo), hi), scale));
+                    __m256i gi = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(g, lo), hi), scale));
+                    __m256i bi = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(b, lo), hi), scale));
+
+                    // Assemble 8 RGBA pixels (0xAABBGGRR little-endian)
+                    // with shifts and ors — the channels are already in
+                    // [0, 255] after the clamp — and write them with a
+                    // single 32-byte store
+                    __m256i rgba = _mm256_or_si256(
+                        _mm256_or_si256(ri, _mm256_slli_epi32(gi, 8)),
+                        _mm256_or_si256(_mm256_slli_epi32(bi, 16), _mm256_set1_epi32(static_cast<int>(0xFF000000u))));
+
+                    // The framebuffer is written once here and then only
+                    // read by the texture upload — stream the pixels past
+                    // the cache so ~3.5 MB of it is not evicted per frame.
+                    // Rows are 32-byte aligned for any width that is a
+                    // multiple of 8 (the buffer itself is aligned by its
+                    // allocator); odd tails take the unaligned store.
+                    uint32_t* dst = &framebuffer[j * image_width + i];
+                    if (reinterpret_cast<uintptr_t>(dst) % 32 == 0) {
+                        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst), rgba);
+                    } else {
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), rgba);
+                    }
+                }
+
+                // Scalar tail for tile widths that are not a multiple of
+                // 8; the direction advances by one pixel_delta_u per
+                // pixel instead of being rebuilt from scratch
+                vec3 ray_dir = row_base + i * pixel_delta_u;
+                for (; i < i_end; i++, ray_dir += pixel_delta_u) {
+                    color pixel_color = ray_color(ray(origin, ray_dir));
+                    framebuffer[j * image_width + i] = 0xFF000000u
+                        | (static_cast<uint32_t>(256 * std::clamp(pixel_color.z(), 0.0f, 0.999f)) << 16)
+                        | (static_cast<uint32_t>(256 * std::clamp(pixel_color.y(), 0.0f, 0.999f)) << 8)
+                        |  static_cast<uint32_t>(256 * std::clamp(pixel_color.x(), 0.0f, 0.999f));
+                }
+            }
+        }
+    }
+
+    // Non-temporal stores are weakly ordered; fence before the caller hands
+    // the buffer to the texture upload (or the other thread)
+    _mm_sfence();
+#else
+    // |d(i)|² for d(i) = row_start + i * pixel_delta_u is a quadratic in i,
+    // so along a row it advances by a first difference that itself grows by
+    // the constant 2|du|² — two adds per pixel replace the dot product.
+    const float du_len2 = pixel_delta_u.length_squared();
+    const float two_du_len2 = 2.0f * du_len2;
+
+#pragma omp parallel for collapse(2) schedule(dynamic)
+    for (int jj = 0; jj < image_height; jj += kTileH) {
+        for (int ii = 0; ii < image_width; ii += kTileW) {
+            const int j_end = std::min(jj + kTileH, image_height);
+            const int i_end = std::min(ii + kTileW, image_width);
+            // Both index multiplies are strength-reduced to adds: the row
+            // start advances by pixel_delta_v per row and the direction by
+            // pixel_delta_u per pixel
+            vec3 row_start = pixel00_loc + jj * pixel_delta_v + ii * pixel_delta_u - origin;
+            for (int j = jj; j < j_end; j++, row_start += pixel_delta_v) {
+                vec3 ray_dir = row_start;
+                float dir_len2 = ray_dir.length_squared();
+                float dir_len2_step = 2.0f * dot(ray_dir, pixel_delta_u) + du_len2;
+                for (int i = ii; i < i_end; i++, ray_dir += pixel_delta_u,
+                         dir_len2 += dir_len2_step, dir_len2_step += two_du_len2) {
+                    color pixel_color = ray_color(ray(origin, ray_dir), dir_len2);
+                    framebuffer[j * image_width + i] = 0xFF000000u
+                        | (static_cast<uint32_t>(256 * std::clamp(pixel_color.z(), 0.0f, 0.999f)) << 16)
+                        | (static_cast<uint32_t>(256 * std::clamp(pixel_color.y(), 0.0f, 0.999f)) << 8)
+                        |  static_cast<uint32_t>(256 * std::clamp(pixel_color.x(), 0.0f, 0.999f));
+                }
+            }
+        }
+    }
+#endif
+}
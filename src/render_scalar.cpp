@@ -0,0 +1,4 @@
+// Portable fallback kernel: compiled without SIMD flags, so render_impl.h
+// takes its scalar arm on any target.
+#define RT_RENDER_IMPL_NAME render_framebuffer_scalar
+#include "render_impl.h"